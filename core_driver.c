@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "port_core.h"
+
+
+#define DRIVER_TIMESTEPS 200000
+#define DRIVER_SHIPS_PER_STEP 2
+
+
+// in-process driver for port_core: a docking check, a queue order check and a throughput run for every built-in policy, no IPC needed.
+// gcc core_driver.c port_core.c -o core_driver.out && ./core_driver.out
+
+
+const char* policy_names[] = {"default", "fewest_cargo", "short_dock", "drain_outgoing"};
+
+SchedulerConfig config;
+PortCore core;
+DecisionList decisions;
+
+
+void setup_docks(int num_docks){
+    memset(&config, 0, sizeof(config));
+    config.num_solvers = 2;
+    config.num_docks = num_docks;
+    for(int i = 0; i < num_docks; i++){
+        Dock* dock = &config.docks[i];
+        dock->dockId = i;
+        dock->category = 1 + i % MAX_DOCK_CAT;
+        dock->crane_count = dock->category;
+        dock->dockedShipId = -1;
+        dock->dockedTimestep = -1;
+        dock->lastCargoTimestep = -1;
+        for(int c = 0; c < dock->crane_count; c++){
+            dock->cranes[c].craneId = c;
+            dock->cranes[c].capacity = 5 + c;
+        }
+    }
+}
+
+
+void make_ship(ShipRequest* ship, int shipId, int timestep, int category, int direction, int emergency, int numCargo){
+    memset(ship, 0, sizeof(*ship));
+    ship->shipId = shipId;
+    ship->timestep = timestep;
+    ship->category = category;
+    ship->direction = direction;
+    ship->emergency = emergency;
+    ship->waitingTime = 5;
+    ship->numCargo = numCargo;
+    for(int k = 0; k < numCargo; k++){
+        ship->cargo[k] = 1 + k % 5;
+    }
+}
+
+
+int count_decisions(int type){
+    int n = 0;
+    for(int i = 0; i < decisions.count; i++){
+        if(decisions.items[i].type == type) n++;
+    }
+    return n;
+}
+
+
+// a ship that cannot dock must not stop the ships behind it in the same queue from being tried
+int check_blocked_head(const SchedulingPolicy* policy){
+    setup_docks(3);
+    config.docks[0].category = 1;
+    config.docks[1].category = 3;
+    config.docks[1].occupied = 1;
+    config.docks[2].category = 3;
+    config.docks[2].occupied = 1;
+    core_init(&core, &config, policy);
+
+    ShipRequest ships[2];
+    make_ship(&ships[0], 1, 1, 3, 1, 1, 1);
+    make_ship(&ships[1], 2, 1, 1, 1, 1, 5);
+    core_advance(&core, ships, 2, 1, &decisions);
+
+    if(count_decisions(DECISION_DOCK) != 1 || decisions.items[0].shipId != 2){
+        printf("%-16s FAILED: emergency ship 2 was not docked behind an undockable ship\n", policy->name);
+        return 0;
+    }
+    return 1;
+}
+
+
+// regular ships come out in deadline order even once the ring has wrapped past its last slot
+int check_regular_order(const SchedulingPolicy* policy){
+    Queue q;
+    ShipRequest ship;
+    InitQueue(&q);
+    make_ship(&ship, 0, 1, 1, 1, 0, 1);
+    for(int i = 0; i < 990; i++){
+        enqueue(&q, ship);
+        dequeue(&q);
+    }
+
+    // later arrivals have earlier deadlines and fewer cargo, so every policy must reverse them
+    int count = 20;
+    for(int i = 0; i < count; i++){
+        make_ship(&ship, i, 1, 1, 1, 0, count - i);
+        ship.waitingTime = 100 - 4 * i;
+        policy->enqueue_ship(&q, &ship, QUEUE_REGULAR, policy->ctx);
+    }
+
+    if(getQueueSize(&q) != count){
+        printf("%-16s FAILED: regular queue holds %d ships, expected %d\n", policy->name, getQueueSize(&q), count);
+        return 0;
+    }
+    for(int i = count - 1; i >= 0; i--){
+        ship = dequeue(&q);
+        if(ship.shipId != i){
+            printf("%-16s FAILED: regular queue gave ship %d, expected %d\n", policy->name, ship.shipId, i);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+void run_throughput(const SchedulingPolicy* policy){
+    setup_docks(MAX_DOCKS);
+    core_init(&core, &config, policy);
+
+    ShipRequest requests[DRIVER_SHIPS_PER_STEP];
+    long long ships = 0, docked = 0, undocked = 0;
+    unsigned int seed = 42;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(int t = 1; t <= DRIVER_TIMESTEPS; t++){
+        for(int k = 0; k < DRIVER_SHIPS_PER_STEP; k++){
+            seed = seed * 1103515245 + 12345;
+            int direction = (seed >> 8) % 3 == 0 ? -1 : 1;
+            make_ship(&requests[k], (int)ships++, t, 1 + (seed >> 12) % 20, direction, (seed >> 16) % 10 == 0, 1 + (seed >> 20) % 8);
+        }
+        core_advance(&core, requests, DRIVER_SHIPS_PER_STEP, t, &decisions);
+        for(int i = 0; i < decisions.count; i++){
+            if(decisions.items[i].type == DECISION_DOCK) docked++;
+            if(decisions.items[i].type == DECISION_UNDOCK){
+                core_undock_done(&core, decisions.items[i].dockId);
+                undocked++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%-16s %10lld %10lld %10lld %14.0f\n", policy->name, ships, docked, undocked, ships / secs);
+}
+
+
+int main(){
+    int ok = 1;
+    for(int i = 0; i < (int)(sizeof(policy_names)/sizeof(policy_names[0])); i++){
+        ok &= check_blocked_head(core_find_policy(policy_names[i]));
+        ok &= check_regular_order(core_find_policy(policy_names[i]));
+    }
+
+    printf("%-16s %10s %10s %10s %14s\n", "Policy", "Ships", "Docked", "Undocked", "Ships/s");
+    for(int i = 0; i < (int)(sizeof(policy_names)/sizeof(policy_names[0])); i++){
+        run_throughput(core_find_policy(policy_names[i]));
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "port_core.h"
+
+
+void InitQueue(Queue* q){
+    q->front = 0;
+    q->rear = 0;
+}
+
+
+void enqueue(Queue* q, ShipRequest ship){
+    if ((q->rear + 1) % 1000 == q->front) {
+        printf("Queue is full. Cannot enqueue.\n");
+        return;
+    }
+
+    q->data[q->rear] = ship;
+    q->rear = (q->rear + 1) % 1000;
+}
+
+void enQueueRegularShips(Queue* q,ShipRequest ship){
+    int priority = ship.timestep + ship.waitingTime;
+    if ((q->rear + 1) % 1000 == q->front) {
+        printf("Queue is full. Cannot enqueue.\n");
+        return;
+    }
+
+
+    int size = (q->rear-q->front+1000)%1000;
+    int i = size;
+    while (i > 0){
+        int prevIndex=(q->front + i-1)%1000;
+        int currIndex= (q->front +i)%1000;
+
+        int currPriority= q->data[prevIndex].timestep + q->data[prevIndex].waitingTime;
+
+        if (priority >= currPriority) break;
+
+        q->data[currIndex] = q->data[prevIndex];
+        i--;
+    }
+
+    int insertIndex = (q->front + i)%1000;
+    q->data[insertIndex] = ship;
+    q->rear = (q->rear + 1)%1000;
+}
+
+
+ShipRequest dequeue(Queue* q) {
+    ShipRequest empty = {0};
+    if (q->front == q->rear) {
+        printf("Queue is empty. Cannot dequeue.\n");
+        return empty;
+    }
+
+
+    ShipRequest ship = q->data[q->front];
+    q->front = (q->front+1)%1000;
+    return ship;
+}
+
+
+int isQueueEmpty(Queue* q){
+    return q->front == q->rear;
+}
+
+
+int getQueueSize(Queue* q){
+    if(q->rear >= q->front){
+        return q->rear - q->front;
+    }
+    else{
+        return (1000 - q->front + q->rear);
+    }
+}
+
+
+
+int compare_numCargo(const void *a, const void *b) {
+    ShipRequest *shipA = (ShipRequest *)a;
+    ShipRequest *shipB = (ShipRequest *)b;
+    return shipA->numCargo - shipB->numCargo;
+}
+
+
+void sort_queue_by_numCargo(Queue *q) {
+    int size = MAX_NEW_SHIP_REQS * 10;
+    int n = (q->rear - q->front + size) % size;
+    if (n <= 1) return;
+
+    ShipRequest temp[n];
+    for (int i = 0; i < n; ++i) {
+        temp[i] = q->data[(q->front + i) % size];
+    }
+    qsort(temp, n, sizeof(ShipRequest), compare_numCargo);
+    for (int i = 0; i < n; ++i) {
+        q->data[(q->front + i) % size] = temp[i];
+    }
+}
+
+
+void default_enqueue_ship(Queue* q, ShipRequest* ship, int kind, void* ctx){
+    if(kind == QUEUE_REGULAR){
+        enQueueRegularShips(q,*ship);
+    }
+    else{
+        enqueue(q,*ship);
+    }
+}
+
+
+// smallest free dock that fits the ship's category
+Dock* default_choose_dock(SchedulerConfig* config, ShipRequest* ship, int timestep, void* ctx){
+    Dock* bestDock = NULL;
+
+    for(int i=0; i < config->num_docks; i++){
+        Dock* dock = &config->docks[i];
+        if(!dock->occupied && dock->category >= ship->category){
+            if(bestDock == NULL || dock->category < bestDock->category){
+                bestDock = dock;
+            }
+        }
+    }
+    return bestDock;
+}
+
+
+// smallest unused crane that can lift the cargo
+int default_choose_crane(Dock* dock, int cargoWeight, const int crane_used[], void* ctx){
+    int bestCraneIdx = -1;
+    int minCap = 10000;
+
+    for(int c = 0; c < dock->crane_count; c++){
+        if(crane_used[c]) continue;
+
+        int craneCap = dock->cranes[c].capacity;
+
+        if(craneCap >= cargoWeight && craneCap < minCap){
+            minCap = craneCap;
+            bestCraneIdx = c;
+        }
+    }
+    return bestCraneIdx;
+}
+
+
+// insertion keeps the queue sorted by numCargo, same order sort_queue_by_numCargo gives.
+// emergencies stay first come first served
+void fewest_cargo_enqueue_ship(Queue* q, ShipRequest* ship, int kind, void* ctx){
+    if(kind == QUEUE_EMERGENCY){
+        enqueue(q,*ship);
+        return;
+    }
+
+    if ((q->rear + 1) % 1000 == q->front) {
+        printf("Queue is full. Cannot enqueue.\n");
+        return;
+    }
+
+    int i = getQueueSize(q);
+    while (i > 0){
+        int prevIndex = (q->front + i - 1) % 1000;
+        if (ship->numCargo >= q->data[prevIndex].numCargo) break;
+        q->data[(q->front + i) % 1000] = q->data[prevIndex];
+        i--;
+    }
+
+    q->data[(q->front + i) % 1000] = *ship;
+    q->rear = (q->rear + 1) % 1000;
+}
+
+
+// timesteps the dock's cranes need to move every cargo item, -1 if some item is too heavy for all of them
+int core_dock_steps(Dock* dock, ShipRequest* ship){
+    int maxCap = 0;
+    for(int c = 0; c < dock->crane_count; c++){
+        if(dock->cranes[c].capacity > maxCap) maxCap = dock->cranes[c].capacity;
+    }
+
+    int remaining = 0;
+    for(int k = 0; k < ship->numCargo; k++){
+        if(ship->cargo[k] == -24) continue;
+        if(ship->cargo[k] > maxCap) return -1;
+        remaining++;
+    }
+    if(dock->crane_count == 0) return remaining > 0 ? -1 : 0;
+    return (remaining + dock->crane_count - 1) / dock->crane_count;
+}
+
+
+// fewest timesteps at the dock means the shortest auth string to crack, ties go to the smaller dock.
+// emergency ships keep best-fit so a large dock is not taken from a later emergency
+Dock* short_dock_choose_dock(SchedulerConfig* config, ShipRequest* ship, int timestep, void* ctx){
+    if(ship->emergency){
+        return default_choose_dock(config, ship, timestep, ctx);
+    }
+
+    Dock* bestDock = NULL;
+    int bestSteps = 0;
+
+    for(int i=0; i < config->num_docks; i++){
+        Dock* dock = &config->docks[i];
+        if(dock->occupied || dock->category < ship->category) continue;
+
+        int steps = core_dock_steps(dock, ship);
+        if(steps < 0) continue;
+        if(bestDock == NULL || steps < bestSteps || (steps == bestSteps && dock->category < bestDock->category)){
+            bestDock = dock;
+            bestSteps = steps;
+        }
+    }
+    return bestDock;
+}
+
+
+const SchedulingPolicy policy_default = {
+    "default", default_enqueue_ship, default_choose_dock, default_choose_crane, 0, NULL
+};
+
+const SchedulingPolicy policy_fewest_cargo = {
+    "fewest_cargo", fewest_cargo_enqueue_ship, default_choose_dock, default_choose_crane, 0, NULL
+};
+
+const SchedulingPolicy policy_short_dock = {
+    "short_dock", default_enqueue_ship, short_dock_choose_dock, default_choose_crane, 0, NULL
+};
+
+const SchedulingPolicy policy_drain_outgoing = {
+    "drain_outgoing", default_enqueue_ship, short_dock_choose_dock, default_choose_crane, 1, NULL
+};
+
+
+const SchedulingPolicy* core_find_policy(const char* name){
+    const SchedulingPolicy* policies[] = {&policy_default, &policy_fewest_cargo, &policy_short_dock, &policy_drain_outgoing};
+    for(int i = 0; i < (int)(sizeof(policies)/sizeof(policies[0])); i++){
+        if(strcmp(policies[i]->name, name) == 0){
+            return policies[i];
+        }
+    }
+    return NULL;
+}
+
+
+void core_init(PortCore* core, SchedulerConfig* config, const SchedulingPolicy* policy){
+    core->config = config;
+    InitQueue(&core->emergency);
+    InitQueue(&core->regular);
+    InitQueue(&core->outgoing);
+    core->policy = *policy;
+}
+
+
+void core_set_policy(PortCore* core, const SchedulingPolicy* policy){
+    core->policy = *policy;
+}
+
+
+Decision* add_decision(DecisionList* out, int type){
+    Decision* d = &out->items[out->count++];
+    memset(d, 0, sizeof(*d));
+    d->type = type;
+    return d;
+}
+
+
+int core_dock_ship(PortCore* core, ShipRequest* ship, int timestep, int reg, DecisionList* out){
+    if(reg == 0){
+        if(timestep > ship->timestep + ship->waitingTime){
+            //printf("This ship %d, was waiting here forever, will return\n",ship->shipId);
+            return 1;
+        }
+    }
+
+    Dock* bestDock = core->policy.choose_dock(core->config, ship, timestep, core->policy.ctx);
+
+    if(bestDock != NULL){
+        bestDock->occupied = 1;
+        bestDock->dockedShipId = ship->shipId;
+        bestDock->dockedTimestep = timestep;
+        bestDock->dockedDockShipDirection = ship->direction;
+        bestDock->lastCargoTimestep = -1;
+        bestDock->readyToUndock = 0;
+        bestDock->ship = *(ship);
+
+        Decision* d = add_decision(out, DECISION_DOCK);
+        d->dockId = bestDock->dockId;
+        d->shipId = ship->shipId;
+        d->direction = ship->direction;
+        return 1;
+    }
+    return 0;
+}
+
+
+// a ship that cannot dock goes behind the ships not yet tried, so every ship gets one try per pass
+// and the waiting ships keep the order the policy gave them
+void core_dock_queue(PortCore* core, Queue* q, int kind, int timestep, DecisionList* out){
+    int size = getQueueSize(q);
+    for(int i=0; i < size; i++){
+        ShipRequest ship = dequeue(q);
+        if(!core_dock_ship(core, &ship, timestep, kind != QUEUE_REGULAR, out)){
+            enqueue(q, ship);
+        }
+    }
+}
+
+
+void core_load_unload(PortCore* core, int timestep, DecisionList* out){
+    SchedulerConfig* config = core->config;
+
+    for(int d = 0; d < config->num_docks; d++){
+        Dock* dock = &config->docks[d];
+
+        if(!dock->occupied || dock->dockedTimestep == 0 ||timestep == dock->dockedTimestep){
+            continue;
+        }
+
+        ShipRequest* dockedShip = &dock->ship;
+        int crane_used[MAX_DOCK_CAT] = {0};
+        for(int k=0; k < dockedShip->numCargo; k++){
+            if(dockedShip->cargo[k]==-24) continue;
+
+            int bestCraneIdx = core->policy.choose_crane(dock, dockedShip->cargo[k], crane_used, core->policy.ctx);
+            if(bestCraneIdx != -1){
+                Decision* dec = add_decision(out, DECISION_CARGO);
+                dec->dockId = dock->dockId;
+                dec->shipId = dockedShip->shipId;
+                dec->direction = dockedShip->direction;
+                dec->cargoId = k;
+                dec->craneId = dock->cranes[bestCraneIdx].craneId;
+                dockedShip->cargo[k]  = -24;
+                crane_used[bestCraneIdx] = 1;
+                dock->lastCargoTimestep = timestep;
+            }
+        }
+
+
+        int allDone = 1;
+        for (int i = 0; i < dockedShip->numCargo; i++) {
+            if (dockedShip->cargo[i] != -24) {
+                allDone = 0;
+                break;
+            }
+        }
+
+        if (allDone) {
+            dock->readyToUndock = 1;
+        }
+    }
+}
+
+
+// one timestep: intake, docking (emergency, then regular and outgoing), cargo moves, then ships ready to leave.
+// UNDOCK decisions keep the dock occupied until the caller confirms with core_undock_done()
+void core_advance(PortCore* core, ShipRequest* requests, int num_requests, int timestep, DecisionList* out){
+    out->count = 0;
+
+    for(int i=0; i < num_requests; i++){
+        ShipRequest* request = &requests[i];
+        if(request->direction == 1 && request->emergency == 1){
+            core->policy.enqueue_ship(&core->emergency, request, QUEUE_EMERGENCY, core->policy.ctx);
+        }
+        else if(request->direction == -1){
+            core->policy.enqueue_ship(&core->outgoing, request, QUEUE_OUTGOING, core->policy.ctx);
+        }
+        else{
+            core->policy.enqueue_ship(&core->regular, request, QUEUE_REGULAR, core->policy.ctx);
+        }
+    }
+
+    core_dock_queue(core, &core->emergency, QUEUE_EMERGENCY, timestep, out);
+    if(core->policy.outgoing_first){
+        core_dock_queue(core, &core->outgoing, QUEUE_OUTGOING, timestep, out);
+        core_dock_queue(core, &core->regular, QUEUE_REGULAR, timestep, out);
+    }
+    else{
+        core_dock_queue(core, &core->regular, QUEUE_REGULAR, timestep, out);
+        core_dock_queue(core, &core->outgoing, QUEUE_OUTGOING, timestep, out);
+    }
+
+    core_load_unload(core, timestep, out);
+
+    for(int i=0; i < core->config->num_docks; i++){
+        Dock* dock = &core->config->docks[i];
+        if(dock->occupied && dock->lastCargoTimestep != -1 && dock->lastCargoTimestep < timestep && dock->readyToUndock == 1){
+            Decision* d = add_decision(out, DECISION_UNDOCK);
+            d->dockId = dock->dockId;
+            d->shipId = dock->dockedShipId;
+            d->direction = dock->dockedDockShipDirection;
+        }
+    }
+}
+
+
+void core_undock_done(PortCore* core, int dockId){
+    core->config->docks[dockId].occupied = 0;
+}
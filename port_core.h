@@ -0,0 +1,140 @@
+#ifndef PORT_CORE_H
+#define PORT_CORE_H
+
+
+#define MAX_DOCKS 30
+#define MAX_DOCK_CAT 25
+#define MAX_SHIP_CAT 25
+#define MAX_REG_INC 500
+#define MAX_EME_INC 100
+#define MAX_CAP_OF_CRANE 30
+#define MAX_CARGO_SHIP 200
+#define MAX_SOLVERS 8
+#define MAX_NEW_SHIP_REQS 100
+#define MAX_DECISIONS (MAX_DOCKS * (MAX_DOCK_CAT + 2))
+
+#define QUEUE_EMERGENCY 0
+#define QUEUE_REGULAR 1
+#define QUEUE_OUTGOING 2
+
+#define DECISION_DOCK 2
+#define DECISION_UNDOCK 3
+#define DECISION_CARGO 4
+
+
+
+
+typedef struct{
+    int craneId;
+    int capacity;
+}Crane;
+
+
+typedef struct ShipRequest{
+    int shipId;
+    int timestep;
+    int category;
+    int direction;
+    int emergency;
+    int waitingTime;
+    int numCargo;
+    int cargo[MAX_CARGO_SHIP];
+} ShipRequest;
+
+
+typedef struct{
+    int dockId;
+    int category;
+    int occupied;
+    int dockedShipId;
+    int dockedDockShipDirection;
+    int dockedTimestep;
+    int lastCargoTimestep;
+    int readyToUndock;
+    Crane cranes[MAX_DOCK_CAT];
+    int crane_count;
+    ShipRequest ship;
+}Dock;
+
+
+typedef struct{
+    int shared_mem_key;
+    int main_msg_queue_key;
+    int num_solvers;
+    int solver_msg_queues[MAX_SOLVERS];
+    int num_docks;
+    Dock docks[MAX_DOCKS];
+}SchedulerConfig;
+
+
+typedef struct{
+    ShipRequest data[MAX_NEW_SHIP_REQS*10];
+    int front;
+    int rear;
+}Queue;
+
+
+// one action for the validator, type matches the mtype the scheduler sends it with
+typedef struct{
+    int type;
+    int shipId;
+    int direction;
+    int dockId;
+    int cargoId;
+    int craneId;
+}Decision;
+
+
+typedef struct{
+    int count;
+    Decision items[MAX_DECISIONS];
+}DecisionList;
+
+
+// scheduling policy, every callback gets ctx back so a policy can carry its own state
+typedef struct{
+    const char* name;
+    // put a newly arrived ship into the queue for its kind (QUEUE_*)
+    void (*enqueue_ship)(Queue* q, ShipRequest* ship, int kind, void* ctx);
+    // pick a free dock for the ship, NULL to leave it waiting
+    Dock* (*choose_dock)(SchedulerConfig* config, ShipRequest* ship, int timestep, void* ctx);
+    // pick an unused crane index for a cargo item, -1 if none fits
+    int (*choose_crane)(Dock* dock, int cargoWeight, const int crane_used[], void* ctx);
+    // dock outgoing ships before regular ones, emergencies always go first
+    int outgoing_first;
+    void* ctx;
+}SchedulingPolicy;
+
+
+typedef struct{
+    SchedulerConfig* config;
+    Queue emergency;
+    Queue regular;
+    Queue outgoing;
+    SchedulingPolicy policy;
+}PortCore;
+
+
+extern const SchedulingPolicy policy_default;
+extern const SchedulingPolicy policy_fewest_cargo;
+extern const SchedulingPolicy policy_short_dock;
+extern const SchedulingPolicy policy_drain_outgoing;
+
+
+void InitQueue(Queue* q);
+void enqueue(Queue* q, ShipRequest ship);
+void enQueueRegularShips(Queue* q,ShipRequest ship);
+ShipRequest dequeue(Queue* q);
+int isQueueEmpty(Queue* q);
+int getQueueSize(Queue* q);
+void sort_queue_by_numCargo(Queue *q);
+
+void core_init(PortCore* core, SchedulerConfig* config, const SchedulingPolicy* policy);
+void core_set_policy(PortCore* core, const SchedulingPolicy* policy);
+const SchedulingPolicy* core_find_policy(const char* name);
+void core_advance(PortCore* core, ShipRequest* requests, int num_requests, int timestep, DecisionList* out);
+void core_undock_done(PortCore* core, int dockId);
+int core_dock_steps(Dock* dock, ShipRequest* ship);
+
+
+#endif
@@ -11,65 +11,36 @@
 #include <semaphore.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include "port_core.h"
 
 
-#define MAX_DOCKS 30
-#define MAX_DOCK_CAT 25
-#define MAX_SHIP_CAT 25
-#define MAX_REG_INC 500
-#define MAX_EME_INC 100
-#define MAX_CAP_OF_CRANE 30
-#define MAX_CARGO_SHIP 200
-#define MAX_SOLVERS 8
-#define MAX_NEW_SHIP_REQS 100
 #define MAX_STR_LEN 100
+#define CKPT_MAGIC 0x504F5254
+#define CKPT_VERSION 4
+#define MAX_SCENARIOS 64
+#define BATCH_KEY_BASE 0x5C000000
+#define SOLVER_CANCELLED -2
+#define STALE_DRAIN_TRIES 200
+#define STALE_DRAIN_WAIT_US 1000
+#define DEFAULT_WALL_BUDGET_S 360
+#define DEFAULT_GUESS_NS 50000.0
+#define BUDGET_NORMAL 0
+#define BUDGET_TIGHT 1
+#define BUDGET_CRITICAL 2
+#define BUDGET_TIGHT_AT 0.7
+#define BUDGET_CRITICAL_AT 0.9
+#define BUDGET_HYSTERESIS 0.05
 
 
 
 
-typedef struct{
-    int craneId;
-    int capacity;
-}Crane;
-
-
-typedef struct ShipRequest{
-    int shipId;
-    int timestep;
-    int category;                        
-    int direction;                        
-    int emergency;                        
-    int waitingTime;
-    int numCargo;                    
-    int cargo[MAX_CARGO_SHIP];  
-} ShipRequest;
-
-
-typedef struct{
-    int dockId;
-    int category;
-    int occupied;
-    int dockedShipId;
-    int dockedDockShipDirection;
-    int dockedTimestep;
-    int lastCargoTimestep;
-    int readyToUndock;
-    Crane cranes[MAX_DOCK_CAT];
-    int crane_count;
-    ShipRequest ship;
-}Dock;
-
-
-typedef struct{
-    int shared_mem_key;
-    int main_msg_queue_key;
-    int num_solvers;
-    int solver_msg_queues[MAX_SOLVERS];
-    int num_docks;
-    Dock docks[MAX_DOCKS];
-}SchedulerConfig;
-
-
 typedef struct MessageStruct {
     long mtype;  
     int timestep;
@@ -108,29 +79,37 @@ typedef struct SolverResponse{
 }SolverResponse;
 
 
-typedef struct{
-    ShipRequest data[MAX_NEW_SHIP_REQS*10];
-    int front;
-    int rear;
-}Queue;
-
-
 typedef struct{
     int solver_queue_key;
     SolverRequest setupMsg;
 }SolverThreadArgs;
 
 
+// one crack of one dock's auth string, shared by all solver threads working on it
+typedef struct{
+    atomic_bool found;
+    char* result;
+    pthread_mutex_t result_lock;
+    int num_threads;
+    pthread_t threads[MAX_SOLVERS];
+    int solver_q[MAX_SOLVERS];
+    int sentinelSent[MAX_SOLVERS];
+}CrackSession;
+
+
 typedef struct {
     int thread_id;
     int num_solvers;
-    int total;
+    long long total;
     int length;
     int solver_q;
     int dockId;
-    char* result;
-    atomic_bool* found;
-    pthread_mutex_t* result_lock;
+    long long start;
+    long long* progress;
+    int outstanding;
+    int sentinelSeen;
+    long long guesses;
+    CrackSession* session;
 } ThreadArgs;
 
 typedef struct{
@@ -139,39 +118,133 @@ typedef struct{
     int timestep;
 } DockThreadArgs;
 
+
+typedef struct{
+    int timesteps;
+    int shipsDocked;
+    int shipsUndocked;
+    long long crackNsTotal;
+    long long crackNsMax;
+    long long guessesTotal;
+    long long dockStepsTotal;
+    long long wallNs;
+}RunStats;
+
+
+typedef struct{
+    char testcase[32];
+    char dir[256];
+    SchedulerConfig config;
+    // scheduler options in effect where the testcase appeared on the --batch line
+    int timestepCap;
+    long long wallBudgetNs;
+    const SchedulingPolicy* policy;
+    pid_t validatorPid;
+    pid_t schedulerPid;
+    int validatorStatus;
+    int schedulerStatus;
+}Scenario;
+
+
+// crack progress for one dock, next[k] is the next candidate index solver thread k will try
+typedef struct{
+    int shipId;
+    int dockedTimestep;
+    int length;
+    long long next[MAX_SOLVERS];
+}CrackProgress;
+
+
+typedef struct{
+    unsigned long seq;
+    int timestep;
+    SchedulerConfig config;
+    Queue emergency;
+    Queue regular;
+    Queue outgoing;
+    DecisionList decisions;
+    int sent;
+    int advanceSent;
+    RunStats stats;
+}CheckpointSlot;
+
+
+// layout of the mmap'd checkpoint file, two slots so a crash mid-write never loses the last good snapshot.
+// a slot holds the state right after core_advance() plus that timestep's decisions, sent[] is how many have gone out
+typedef struct{
+    int magic;
+    int version;
+    atomic_int active;
+    long long runStartNs;
+    int budgetLevel;
+    int inFlightValid;
+    MessageStruct inFlight;
+    CrackProgress crack[MAX_DOCKS];
+    CheckpointSlot slots[2];
+}CheckpointFile;
+
 char valid_chars[] = {'5','6','7','8','9','.'};
 
 
-bool is_valid_string(char* str, int length){
-    return !(str[0] == '.' || str[length-1] == '.');
+// responses owed on each solver queue by guesses of an earlier crack session
+int solver_stale[MAX_SOLVERS];
+unsigned long crack_generation = 0;
+
+
+// a string may not start or end with '.', so only those candidates are counted
+long long count_valid_strings(int length){
+    if(length <= 0) return 0;
+    if(length == 1) return 5;
+    long long total = 25;
+    for(int i = 2; i < length; i++){
+        if(total > LLONG_MAX / 6) return LLONG_MAX;
+        total *= 6;
+    }
+    return total;
 }
 
 
-void index_to_string(int index,int length,char* out){
+// index is into the valid strings only, so no solver round trip is spent on a guess that cannot match
+void index_to_string(long long index,int length,char* out){
     for(int i= length-1; i >= 0; i--){
-        out[i] = valid_chars[index%6];
-        index /= 6;
+        int base = (i == 0 || i == length-1) ? 5 : 6;
+        out[i] = valid_chars[index%base];
+        index /= base;
     }
     out[length] = '\0';
 }
 
 
+// a sentinel response (a value solvers never send) on every other thread's queue wakes it from msgrcv, or is waiting there if it has not got that far yet
+void crack_session_cancel(CrackSession* session,int self){
+    SolverResponse sentinel;
+    sentinel.mtype = 3;
+    sentinel.guessIsCorrect = SOLVER_CANCELLED;
+
+    for(int k = 0; k < session->num_threads; k++){
+        if(k == self) continue;
+        if(msgsnd(session->solver_q[k], &sentinel, sizeof(SolverResponse) - sizeof(long), 0) == -1){
+            perror("msgsnd cancel");
+            continue;
+        }
+        session->sentinelSent[k] = 1;
+    }
+}
+
+
 void* guess_modulo_thread(void* arg) {
     ThreadArgs* args=(ThreadArgs*)arg;
+    CrackSession* session = args->session;
     char guess[MAX_STR_LEN];
 
 
-    for (int i=0; i<args->total && !*(args->found); i++){
-        if (i % args->num_solvers != args->thread_id) continue;
-
-
+    for (long long i=args->start; i<args->total && !atomic_load(&session->found); i+=args->num_solvers){
         index_to_string(i, args->length, guess);
 
-        if(!is_valid_string(guess,args->length)) continue;
-
 
         SolverRequest req;
         req.mtype = 2;
+        req.dockId = args->dockId;
         strcpy(req.authStringGuess, guess);
 
 
@@ -179,24 +252,38 @@ void* guess_modulo_thread(void* arg) {
             perror("msgsnd");
             continue;
         }
+        args->outstanding = 1;
 
 
         SolverResponse resp;
         if (msgrcv(args->solver_q, &resp, sizeof(SolverResponse) - sizeof(long), 3, 0) == -1){
             perror("msgrcv");
+            args->outstanding = 0;
             continue;
         }
+        if (resp.guessIsCorrect == SOLVER_CANCELLED){
+            args->sentinelSeen = 1;
+            break;
+        }
+        args->outstanding = 0;
+        args->guesses++;
 
 
-        if (resp.guessIsCorrect){
-            pthread_mutex_lock(args->result_lock);
-            if (!*(args->found)) {
-                strcpy(args->result, guess);
-                *(args->found) = true;
+        // a solver answers -1 to a guess it had no dock setup for, that is a wrong guess too
+        if (resp.guessIsCorrect == 1){
+            pthread_mutex_lock(&session->result_lock);
+            if (!atomic_load(&session->found)) {
+                strcpy(session->result, guess);
+                atomic_store(&session->found, true);
             }
-            pthread_mutex_unlock(args->result_lock);
+            pthread_mutex_unlock(&session->result_lock);
+            crack_session_cancel(session, args->thread_id);
             break;
         }
+
+        if(args->progress != NULL){
+            *(args->progress) = i + args->num_solvers;
+        }
     }
 
 
@@ -204,86 +291,208 @@ void* guess_modulo_thread(void* arg) {
 }
 
 
-void InitQueue(Queue* q){
-    q->front = 0;
-    q->rear = 0;
+PortCore core;
+RunStats run_stats;
+
+
+typedef struct{
+    long long wallBudgetNs;
+    int timestepCap;
+    long long startNs;
+    int level;
+}BudgetController;
+
+BudgetController budget = {DEFAULT_WALL_BUDGET_S * 1000000000LL, 0, 0, BUDGET_NORMAL};
+const SchedulingPolicy* budget_policies[] = {&policy_default, &policy_short_dock, &policy_drain_outgoing};
+const double budget_thresholds[] = {0.0, BUDGET_TIGHT_AT, BUDGET_CRITICAL_AT};
+
+
+long long now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
 
+pthread_mutex_t dock_mutex[MAX_DOCKS];
+pthread_mutex_t shared_mem_mutex;
+
+CheckpointFile* checkpoint = NULL;
+char checkpoint_path[256];
 
-void enqueue(Queue* q, ShipRequest ship){
-    if ((q->rear + 1) % 1000 == q->front) {
-        printf("Queue is full. Cannot enqueue.\n");
-        return;
+
+int checkpoint_open(const char* path, int resume){
+    int fd = open(path, resume ? O_RDWR : (O_RDWR | O_CREAT | O_TRUNC), 0666);
+    if(fd == -1){
+        perror("Error opening checkpoint file");
+        return 0;
     }
 
-    q->data[q->rear] = ship;
-    q->rear = (q->rear + 1) % 1000;
-}
+    if(!resume && ftruncate(fd, sizeof(CheckpointFile)) == -1){
+        perror("Error sizing checkpoint file");
+        close(fd);
+        return 0;
+    }
 
-void enQueueRegularShips(Queue* q,ShipRequest ship){
-    int priority = ship.timestep + ship.waitingTime;
-    if ((q->rear + 1) % 1000 == q->front) {
-        printf("Queue is full. Cannot enqueue.\n");
-        return;
+    if(resume && lseek(fd, 0, SEEK_END) < (off_t)sizeof(CheckpointFile)){
+        fprintf(stderr, "Checkpoint file %s is truncated\n", path);
+        close(fd);
+        return 0;
     }
 
+    CheckpointFile* file = mmap(NULL, sizeof(CheckpointFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(file == MAP_FAILED){
+        perror("Error mapping checkpoint file");
+        return 0;
+    }
 
-    int size = (q->rear-q->front+1000)%1000;
-    int insertPos = q->rear;
-    int i = size;
-    while (i > 0){
-        int prevIndex=(q->front + i-1)%MAX_NEW_SHIP_REQS;
-        int currIndex= (q->front +i)%MAX_NEW_SHIP_REQS;
+    if(resume){
+        if(file->magic != CKPT_MAGIC || file->version != CKPT_VERSION || atomic_load(&file->active) < 0){
+            fprintf(stderr, "Checkpoint file %s has no usable snapshot\n", path);
+            munmap(file, sizeof(CheckpointFile));
+            return 0;
+        }
+    }
+    else{
+        file->magic = CKPT_MAGIC;
+        file->version = CKPT_VERSION;
+        file->inFlightValid = 0;
+        file->runStartNs = budget.startNs;
+        file->budgetLevel = budget.level;
+        atomic_store(&file->active, -1);
+        for(int i = 0; i < MAX_DOCKS; i++){
+            file->crack[i].shipId = -1;
+        }
+    }
 
-        int currPriority= q->data[prevIndex].timestep + q->data[prevIndex].waitingTime;
+    checkpoint = file;
+    snprintf(checkpoint_path, sizeof(checkpoint_path), "%s", path);
+    return 1;
+}
 
-        if (priority >= currPriority) break;
 
-        q->data[currIndex] = q->data[prevIndex];
-        i--;
+void copy_queue(Queue* dst, const Queue* src){
+    dst->front = src->front;
+    dst->rear = src->rear;
+    for(int i = src->front; i != src->rear; i = (i + 1) % 1000){
+        dst->data[i] = src->data[i];
     }
-
-    int insertIndex = (q->front + i)%1000;
-    q->data[insertIndex] = ship;
-    q->rear = (q->rear + 1)%1000;
 }
 
 
-ShipRequest dequeue(Queue* q) {
-    ShipRequest empty = {0};
-    if (q->front == q->rear) {
-        printf("Queue is empty. Cannot dequeue.\n");
-        return empty;
+// copies the whole config (about 32KB), the live part of each queue and the used part of the decision list (up to about 19KB).
+// taken before anything of the timestep is sent, so a resume can send exactly what is left
+void checkpoint_save(SchedulerConfig* config, int timestep, DecisionList* decisions){
+    if(checkpoint == NULL) return;
+
+    int cur = atomic_load(&checkpoint->active);
+    int next = (cur == 0) ? 1 : 0;
+    CheckpointSlot* slot = &checkpoint->slots[next];
+
+    slot->seq = (cur == -1) ? 1 : checkpoint->slots[cur].seq + 1;
+    slot->timestep = timestep;
+    slot->config = *config;
+    copy_queue(&slot->emergency, &core.emergency);
+    copy_queue(&slot->regular, &core.regular);
+    copy_queue(&slot->outgoing, &core.outgoing);
+    slot->decisions.count = (decisions != NULL) ? decisions->count : 0;
+    if(decisions != NULL){
+        memcpy(slot->decisions.items, decisions->items, sizeof(Decision) * decisions->count);
     }
+    slot->sent = 0;
+    slot->advanceSent = (decisions == NULL);
+    slot->stats = run_stats;
+
+    atomic_store(&checkpoint->active, next);
+    checkpoint->inFlightValid = 0;
+    msync(checkpoint, sizeof(CheckpointFile), MS_ASYNC);
+}
 
 
-    ShipRequest ship = q->data[q->front];
-    q->front = (q->front+1)%1000;
-    return ship;
+void checkpoint_record_inflight(MessageStruct* msg){
+    if(checkpoint == NULL) return;
+    checkpoint->inFlight = *msg;
+    checkpoint->inFlightValid = 1;
 }
 
 
-int isQueueEmpty(Queue* q){
-    return q->front == q->rear;
+void checkpoint_mark_sent(int sent){
+    if(checkpoint == NULL) return;
+    checkpoint->slots[atomic_load(&checkpoint->active)].sent = sent;
 }
 
 
-int getQueueSize(Queue* q){
-    if(q->rear >= q->front){
-        return q->rear - q->front;
+void checkpoint_mark_advanced(){
+    if(checkpoint == NULL) return;
+    checkpoint->slots[atomic_load(&checkpoint->active)].advanceSent = 1;
+}
+
+
+// undocks already handled free their dock again, unless the crack failed (its progress entry is still set)
+CheckpointSlot* checkpoint_restore(SchedulerConfig* config){
+    CheckpointSlot* slot = &checkpoint->slots[atomic_load(&checkpoint->active)];
+    *config = slot->config;
+    copy_queue(&core.emergency, &slot->emergency);
+    copy_queue(&core.regular, &slot->regular);
+    copy_queue(&core.outgoing, &slot->outgoing);
+
+    // CLOCK_MONOTONIC is system wide, so the budget keeps counting from the original start
+    run_stats = slot->stats;
+    budget.startNs = checkpoint->runStartNs;
+    budget.level = checkpoint->budgetLevel;
+    core_set_policy(&core, budget_policies[budget.level]);
+
+    for(int i = 0; i < slot->sent; i++){
+        Decision* d = &slot->decisions.items[i];
+        if(d->type == DECISION_UNDOCK && checkpoint->crack[d->dockId].shipId == -1){
+            config->docks[d->dockId].occupied = 0;
+        }
     }
-    else{
-        return (1000 - q->front + q->rear);
+    printf("Resumed from snapshot %lu at timestep %d, %d of %d actions sent\n",
+        slot->seq, slot->timestep, slot->sent, slot->decisions.count);
+    return slot;
+}
+
+
+CrackProgress* checkpoint_crack_begin(Dock* dock, int length){
+    if(checkpoint == NULL) return NULL;
+
+    CrackProgress* crack = &checkpoint->crack[dock->dockId];
+    if(crack->shipId != dock->dockedShipId || crack->dockedTimestep != dock->dockedTimestep || crack->length != length){
+        crack->shipId = dock->dockedShipId;
+        crack->dockedTimestep = dock->dockedTimestep;
+        crack->length = length;
+        for(int k = 0; k < MAX_SOLVERS; k++){
+            crack->next[k] = k;
+        }
     }
+    return crack;
 }
 
 
-Queue Emergency_queue;
-Queue Regular_Queue;
-Queue OutGoing_queue;
+void checkpoint_crack_end(int dockId){
+    if(checkpoint == NULL) return;
+    checkpoint->crack[dockId].shipId = -1;
+}
 
-pthread_mutex_t dock_mutex[MAX_DOCKS];
-pthread_mutex_t shared_mem_mutex;
+
+// a failed crack searched everything, so the retry starts over. shipId stays set, checkpoint_restore() reads it as not undocked
+void checkpoint_crack_reset(int dockId){
+    if(checkpoint == NULL) return;
+    for(int k = 0; k < MAX_SOLVERS; k++){
+        checkpoint->crack[dockId].next[k] = k;
+    }
+}
+
+
+void checkpoint_close(int finished){
+    if(checkpoint == NULL) return;
+    munmap(checkpoint, sizeof(CheckpointFile));
+    checkpoint = NULL;
+    if(finished){
+        unlink(checkpoint_path);
+    }
+}
 
 void read_input(const char *fileName,SchedulerConfig *config){
 
@@ -356,126 +565,76 @@ void read_input(const char *fileName,SchedulerConfig *config){
 }
 
 
-int Docking(int main_message_queue,SchedulerConfig* config, MainSharedMemory* shm, ShipRequest* ship,int timestep,int reg){
-    if(reg == 0){
-        if(timestep > ship->timestep + ship->waitingTime){
-            //printf("This ship %d, was waiting here forever, will return\n",ship->shipId);
-            return 1;
+// must run before the setup messages go out, so the new session never reads a response meant for the last one
+void crack_session_open(SchedulerConfig* config){
+    crack_generation++;
+    for(int k = 0; k < config->num_solvers; k++){
+        int qid = msgget(config->solver_msg_queues[k], IPC_CREAT | 0666);
+        if(qid == -1){
+            perror("msgget");
+            continue;
         }
-    }
 
-    Dock* bestDock = NULL;
-
-    for(int i=0; i < config->num_docks; i++){
-        Dock* dock = &config->docks[i];
-        if(!dock->occupied && dock->category >= ship->category){
-            if(bestDock == NULL || dock->category < bestDock->category){
-                bestDock = dock;
+        // a solver that has gone away never answers, so the wait is bounded
+        SolverResponse resp;
+        for(int tries = 0; solver_stale[k] > 0 && tries < STALE_DRAIN_TRIES; ){
+            if(msgrcv(qid, &resp, sizeof(SolverResponse) - sizeof(long), 3, IPC_NOWAIT) != -1){
+                solver_stale[k]--;
+                continue;
+            }
+            if(errno != ENOMSG && errno != EINTR){
+                perror("msgrcv stale response");
+                break;
             }
+            usleep(STALE_DRAIN_WAIT_US);
+            tries++;
         }
-    }
-
-    if(bestDock != NULL){
-        bestDock->occupied = 1;
-        bestDock->dockedShipId = ship->shipId;
-        bestDock->dockedTimestep = timestep;
-        bestDock->dockedDockShipDirection = ship->direction;
-        bestDock->lastCargoTimestep = -1;
-        bestDock->readyToUndock = 0;
-        bestDock->ship = *(ship);
-
-        MessageStruct dock_msg;
-        dock_msg.mtype = 2;
-        dock_msg.dockId = bestDock->dockId;
-        dock_msg.shipId = ship->shipId;
-        dock_msg.direction = ship->direction;
-
-        if (msgsnd(main_message_queue, &dock_msg, sizeof(dock_msg) - sizeof(long), 0) == -1) {
-            perror("Error Docking\n");
-            exit(0);
+        if(solver_stale[k] > 0){
+            fprintf(stderr, "Solver queue %d: gave up on %d stale responses\n", k, solver_stale[k]);
         }
+        solver_stale[k] = 0;
 
-        return 1;
+        // leftovers from a run that died mid-crack
+        SolverRequest req;
+        while(msgrcv(qid, &resp, sizeof(SolverResponse) - sizeof(long), 3, IPC_NOWAIT) != -1);
+        while(msgrcv(qid, &req, sizeof(SolverRequest) - sizeof(long), 2, IPC_NOWAIT) != -1);
     }
-    return 0;
 }
 
 
-void loadUnload(int main_msg_queue,SchedulerConfig* config, MainSharedMemory* shm,int timestep,int num_requests){
-    
-    for(int d = 0; d < config->num_docks; d++){
-        Dock* dock = &config->docks[d];
-        
-        if(!dock->occupied || dock->dockedTimestep == 0 ||timestep == dock->dockedTimestep){
-            continue;
-        }
-    
-        ShipRequest* dockedShip = &dock->ship;
-        int crane_used[MAX_DOCK_CAT] = {0};
-        //printf("%d dockedship NumCargo\n",dockedShip->numCargo);
-        for(int k=0; k < dockedShip->numCargo; k++){
-            if(dockedShip->cargo[k]==-24) continue;
-
-            int cargoSize = dockedShip->cargo[k];
-            int bestCraneIdx = -1;
-            int minCap = 10000;
-
-            for(int c = 0; c < dock->crane_count; c++){
-                if(crane_used[c]) continue;
+// a cancelled guess is taken back off the queue if no solver has read it yet. its response and any unread sentinel
+// are consumed now if already there, otherwise they are owed to the next session
+void crack_session_close(CrackSession* session,ThreadArgs* args,int num_solvers){
+    for(int k = 0; k < num_solvers; k++){
+        int owed = 0;
 
-                //printf("Assigning a crane\n");
-
-                int craneCap = dock->cranes[c].capacity;
-
-                if(craneCap >= cargoSize && craneCap < minCap){
-                    minCap = craneCap;
-                    bestCraneIdx = c;
-                }
-            }
-            if(bestCraneIdx != -1){
-                MessageStruct cargoMsg;
-                cargoMsg.mtype = 4;
-                cargoMsg.dockId = dock->dockId;
-                cargoMsg.shipId = dockedShip->shipId;
-                cargoMsg.direction = dockedShip->direction;
-                cargoMsg.cargoId = k;
-                cargoMsg.craneId = dock->cranes[bestCraneIdx].craneId;
-                if (msgsnd(main_msg_queue, &cargoMsg, sizeof(cargoMsg) - sizeof(long), 0) == -1) {
-                    perror("msgsnd for cargo failed");
-                    exit(EXIT_FAILURE);
-                }
-                dockedShip->cargo[k]  = -24;
-                crane_used[bestCraneIdx] = 1;
-                dock->lastCargoTimestep = timestep;
-            }
-            
+        SolverRequest req;
+        if(args[k].outstanding && msgrcv(args[k].solver_q, &req, sizeof(SolverRequest) - sizeof(long), 2, IPC_NOWAIT) == -1){
+            owed++;
         }
-
-        
-        int allDone = 1;
-        for (int i = 0; i < dockedShip->numCargo; i++) {
-            if (dockedShip->cargo[i] != -24) {
-                allDone = 0;
-                break;
-            }
+        if(session->sentinelSent[k] && !args[k].sentinelSeen){
+            owed++;
         }
 
-        if (allDone) {
-            dock->readyToUndock = 1;
+        SolverResponse resp;
+        while(owed > 0 && msgrcv(args[k].solver_q, &resp, sizeof(SolverResponse) - sizeof(long), 3, IPC_NOWAIT) != -1){
+            owed--;
         }
+        solver_stale[k] += owed;
     }
-
 }
 
-int generate_auth_string(int num_solvers, char* str, int length, SchedulerConfig* config, int dockId) {
-    int total = 1;
-    for (int i = 0; i < length; i++) total *= 6;
+
+int generate_auth_string(int num_solvers, char* str, int length, SchedulerConfig* config, int dockId, CrackProgress* crack) {
+    long long total = count_valid_strings(length);
 
 
-    pthread_t threads[num_solvers];
     ThreadArgs args[num_solvers];
-    atomic_bool found = false;
-    pthread_mutex_t result_lock = PTHREAD_MUTEX_INITIALIZER;
+    CrackSession session;
+    atomic_init(&session.found, false);
+    session.result = str;
+    session.num_threads = num_solvers;
+    pthread_mutex_init(&session.result_lock, NULL);
 
 
     for (int i = 0; i < num_solvers; i++) {
@@ -484,9 +643,12 @@ int generate_auth_string(int num_solvers, char* str, int length, SchedulerConfig
         args[i].total = total;
         args[i].length = length;
         args[i].dockId = dockId;
-        args[i].result = str;
-        args[i].found = &found;
-        args[i].result_lock = &result_lock;
+        args[i].start = (crack != NULL) ? crack->next[i] : i;
+        args[i].progress = (crack != NULL) ? &crack->next[i] : NULL;
+        args[i].outstanding = 0;
+        args[i].sentinelSeen = 0;
+        args[i].guesses = 0;
+        args[i].session = &session;
 
 
         args[i].solver_q = msgget(config->solver_msg_queues[i], IPC_CREAT | 0666);
@@ -494,18 +656,28 @@ int generate_auth_string(int num_solvers, char* str, int length, SchedulerConfig
             perror("msgget");
             return 0;
         }
+        session.solver_q[i] = args[i].solver_q;
+        session.sentinelSent[i] = 0;
+    }
 
 
-        pthread_create(&threads[i], NULL, guess_modulo_thread, &args[i]);
+    for (int i = 0; i < num_solvers; i++) {
+        if (pthread_create(&session.threads[i], NULL, guess_modulo_thread, &args[i]) != 0) {
+            perror("Failed to create solver thread");
+            exit(EXIT_FAILURE);
+        }
     }
 
 
     for (int i = 0; i < num_solvers; i++) {
-        pthread_join(threads[i], NULL);
+        pthread_join(session.threads[i], NULL);
+        run_stats.guessesTotal += args[i].guesses;
     }
+    crack_session_close(&session, args, num_solvers);
+    pthread_mutex_destroy(&session.result_lock);
 
 
-    return found;
+    return atomic_load(&session.found);
 }
 
 
@@ -532,6 +704,8 @@ void unDocking(int main_msg_queue,int solver_msg_queue[],Dock* dock, MainSharedM
     int stringLength = lastCargoTime-dockingTime;
 
 
+    crack_session_open(config);
+
     SolverRequest setupMsg;
     setupMsg.mtype = 1;
     setupMsg.dockId = dock->dockId;
@@ -558,10 +732,18 @@ void unDocking(int main_msg_queue,int solver_msg_queue[],Dock* dock, MainSharedM
 
 
     int solver_q = msgget(solver_msg_queue[0], IPC_CREAT | 0666);
-    if(!generate_auth_string(config->num_solvers,authString,stringLength,config,dock->dockId)){
-        printf("Failed to find validation for dock %d\n",dock->dockId);
+    CrackProgress* crack = checkpoint_crack_begin(dock,stringLength);
+    long long crackStart = now_ns();
+    if(!generate_auth_string(config->num_solvers,authString,stringLength,config,dock->dockId,crack)){
+        printf("Failed to find validation for dock %d (crack session %lu)\n",dock->dockId,crack_generation);
+        checkpoint_crack_reset(dock->dockId);
         return;
     }
+    long long crackNs = now_ns() - crackStart;
+    run_stats.crackNsTotal += crackNs;
+    if(crackNs > run_stats.crackNsMax){
+        run_stats.crackNsMax = crackNs;
+    }
 
 
     strncpy(shared_memory->authStrings[dock->dockId],authString,MAX_STR_LEN);
@@ -583,19 +765,23 @@ void unDocking(int main_msg_queue,int solver_msg_queue[],Dock* dock, MainSharedM
        perror("Error in sending undocking msg\n");
        exit(EXIT_FAILURE);
     }
-    dock->occupied = 0;
+    core_undock_done(&core,dock->dockId);
+    run_stats.shipsUndocked++;
+    run_stats.dockStepsTotal += lastCargoTime - dockingTime;
+    checkpoint_crack_end(dock->dockId);
     //printf("Ship %d undocked from dock %d\n",dock->dockedShipId,dock->dockId);
 }
 
 
-void setup_ipc(SchedulerConfig* config, int* main_msg_queue,int* shm_id, MainSharedMemory **shared_memory){
-    *main_msg_queue = msgget(config->main_msg_queue_key,IPC_CREAT | 0666);
+void setup_ipc(SchedulerConfig* config, int* main_msg_queue,int* shm_id, MainSharedMemory **shared_memory,int create){
+    int flags = create ? (IPC_CREAT | 0666) : 0666;
+    *main_msg_queue = msgget(config->main_msg_queue_key,flags);
     if(*main_msg_queue == -1){
         perror("Error creating main message queue\n");
         exit(EXIT_FAILURE);
     }
      
-    *shm_id = shmget(config->shared_mem_key,sizeof(MainSharedMemory),IPC_CREAT | 0666);
+    *shm_id = shmget(config->shared_mem_key,sizeof(MainSharedMemory),flags);
     if(*shm_id == -1){
         perror("Error accessing shared memory\n");
         exit(EXIT_FAILURE);
@@ -608,28 +794,141 @@ void setup_ipc(SchedulerConfig* config, int* main_msg_queue,int* shm_id, MainSha
     printf("IPC SETUP COMPLETE\n");
 }
 
-int compare_numCargo(const void *a, const void *b) {
-    ShipRequest *shipA = (ShipRequest *)a;
-    ShipRequest *shipB = (ShipRequest *)b;
-    return shipA->numCargo - shipB->numCargo;
+// expected solver round trips to crack a string of this length, half the space on average
+double expected_guesses(int length,int num_solvers){
+    return count_valid_strings(length) / 2.0 / num_solvers;
+}
+
+
+// projects the finish time and timestep from what is docked and queued now, then picks a policy:
+// tight favours short dock times (the crack cost grows 6x per docked timestep), critical also drains outgoing ships first
+void budget_update(SchedulerConfig* config,int timestep){
+    long long elapsed = now_ns() - budget.startNs;
+    // guesses are summed over all solver threads running side by side, so one thread's round trip is num_solvers times the ratio
+    double guessNs = run_stats.guessesTotal > 0 ? (double)run_stats.crackNsTotal * config->num_solvers / run_stats.guessesTotal : DEFAULT_GUESS_NS;
+    double stepNs = run_stats.timesteps > 0 ? (double)(elapsed - run_stats.crackNsTotal) / run_stats.timesteps : 0;
+    double avgStay = run_stats.shipsUndocked > 0 ? (double)run_stats.dockStepsTotal / run_stats.shipsUndocked : 2;
+
+    double dockedCrackNs = 0;
+    int dockedSteps = 0;
+    for(int i = 0; i < config->num_docks; i++){
+        Dock* dock = &config->docks[i];
+        if(!dock->occupied) continue;
+
+        // the string is as long as lastCargoTimestep - dockedTimestep, the last cargo moves at timestep + steps - 1
+        int steps = core_dock_steps(dock, &dock->ship);
+        if(steps < 0) steps = 0;
+        int length = (steps > 0) ? timestep + steps - 1 - dock->dockedTimestep : dock->lastCargoTimestep - dock->dockedTimestep;
+        dockedCrackNs += expected_guesses(length, config->num_solvers) * guessNs;
+        if(steps + 1 > dockedSteps) dockedSteps = steps + 1;
+    }
+
+    int queued = getQueueSize(&core.emergency) + getQueueSize(&core.regular) + getQueueSize(&core.outgoing);
+    double avgCrackNs = run_stats.shipsUndocked > 0 ? (double)run_stats.crackNsTotal / run_stats.shipsUndocked
+                                                    : expected_guesses((int)avgStay, config->num_solvers) * guessNs;
+    double backlogSteps = (double)((queued + config->num_docks - 1) / config->num_docks) * avgStay;
+    double projSteps = timestep + dockedSteps + backlogSteps;
+    double projNs = elapsed + dockedCrackNs + queued * avgCrackNs + (projSteps - timestep) * stepNs;
+
+    double pressure = projNs / budget.wallBudgetNs;
+    if(budget.timestepCap > 0 && projSteps / budget.timestepCap > pressure){
+        pressure = projSteps / budget.timestepCap;
+    }
+
+    int level = BUDGET_NORMAL;
+    if(pressure >= BUDGET_CRITICAL_AT) level = BUDGET_CRITICAL;
+    else if(pressure >= BUDGET_TIGHT_AT) level = BUDGET_TIGHT;
+    if(level < budget.level && pressure >= budget_thresholds[budget.level] - BUDGET_HYSTERESIS){
+        level = budget.level;
+    }
+    if(level == budget.level) return;
+
+    printf("Budget: timestep %d switching %s -> %s (pressure %.2f, wall %.1fs projected %.1fs of %.0fs, timesteps projected %.0f of %d, %d queued)\n",
+        timestep, budget_policies[budget.level]->name, budget_policies[level]->name, pressure,
+        elapsed / 1e9, projNs / 1e9, budget.wallBudgetNs / 1e9, projSteps, budget.timestepCap, queued);
+    budget.level = level;
+    core_set_policy(&core, budget_policies[level]);
+    if(checkpoint != NULL){
+        checkpoint->budgetLevel = level;
+    }
+}
+
+
+void send_decision(int main_msg_queue,Decision* d){
+    MessageStruct msg;
+    memset(&msg,0,sizeof(msg));
+    msg.mtype = d->type;
+    msg.dockId = d->dockId;
+    msg.shipId = d->shipId;
+    msg.direction = d->direction;
+    if(d->type == DECISION_CARGO){
+        msg.cargoId = d->cargoId;
+        msg.craneId = d->craneId;
+    }
+
+    if(msgsnd(main_msg_queue,&msg,sizeof(msg)-sizeof(long),0) == -1){
+        perror(d->type == DECISION_DOCK ? "Error Docking\n" : "msgsnd for cargo failed");
+        exit(EXIT_FAILURE);
+    }
+    if(d->type == DECISION_DOCK){
+        run_stats.shipsDocked++;
+    }
 }
 
 
-void sort_queue_by_numCargo(Queue *q) {
-    int size = MAX_NEW_SHIP_REQS * 10;
-    int n = (q->rear - q->front + size) % size;
-    if (n <= 1) return;
+void finish_timestep(SchedulerConfig* config,int main_msg_queue,MainSharedMemory* shared_memory,DecisionList* decisions,int sent);
+
+
+void process_timestep(SchedulerConfig* config,int main_msg_queue,MainSharedMemory* shared_memory,MessageStruct* rcvMsg){
+    int current_timestamp = rcvMsg->timestep;
+    int num_requests = rcvMsg->numShipRequests;
+
+
+    printf("Current Timestep: %d \n",current_timestamp);
+    budget_update(config,current_timestamp);
+    run_stats.timesteps++;
+    DecisionList decisions;
+    pthread_mutex_lock(&shared_mem_mutex);
+    core_advance(&core,shared_memory->newShipRequests,num_requests,current_timestamp,&decisions);
+    pthread_mutex_unlock(&shared_mem_mutex);
+
+
+    checkpoint_save(config,current_timestamp,&decisions);
+    finish_timestep(config,main_msg_queue,shared_memory,&decisions,0);
+}
+
 
-    ShipRequest temp[n];
-    for (int i = 0; i < n; ++i) {
-        temp[i] = q->data[(q->front + i) % size];
+// sends decisions from index sent onwards, then the timestep advance, moving the checkpoint cursor after each one
+void finish_timestep(SchedulerConfig* config,int main_msg_queue,MainSharedMemory* shared_memory,DecisionList* decisions,int sent){
+    for(int i=sent; i < decisions->count; i++){
+        Decision* d = &decisions->items[i];
+        if(d->type == DECISION_UNDOCK){
+            pthread_mutex_lock(&dock_mutex[d->dockId]);
+            unDocking(main_msg_queue,config->solver_msg_queues,&config->docks[d->dockId],shared_memory,config);
+            pthread_mutex_unlock(&dock_mutex[d->dockId]);
+        }
+        else{
+            send_decision(main_msg_queue,d);
+        }
+        checkpoint_mark_sent(i + 1);
     }
-    qsort(temp, n, sizeof(ShipRequest), compare_numCargo);
-    for (int i = 0; i < n; ++i) {
-        q->data[(q->front + i) % size] = temp[i];
+
+
+
+    MessageStruct msge;
+    msge.mtype = 5;
+
+
+    if(msgsnd(main_msg_queue,&msge,sizeof(msge)-sizeof(long),0) == -1){
+        perror("Error Updating timestamp\n");
+        exit(EXIT_FAILURE);
     }
+    checkpoint_mark_advanced();
+    printf("TimeStamp update request sent\n");
+    usleep(1);
 }
 
+
 void poll_requests(SchedulerConfig* config,int main_msg_queue,MainSharedMemory* shared_memory){
     while(1){
         MessageStruct rcvMsg;
@@ -644,127 +943,454 @@ void poll_requests(SchedulerConfig* config,int main_msg_queue,MainSharedMemory*
             printf("Testcase has concluded\n");
             break;
         }
-        int current_timestamp = rcvMsg.timestep;
-        int num_requests = rcvMsg.numShipRequests;
+        checkpoint_record_inflight(&rcvMsg);
+        process_timestep(config,main_msg_queue,shared_memory,&rcvMsg);
+    }
+}
 
+int run_scheduler(const char* testcase,int resume){
+    budget.startNs = now_ns();
+    CheckpointSlot* resumeSlot = NULL;
+    SchedulerConfig sched;
+    char fileName[256];
+    char checkpointName[256];
+    snprintf(fileName,sizeof(fileName),"testcase%s/input.txt",testcase);
+    snprintf(checkpointName,sizeof(checkpointName),"testcase%s/scheduler.ckpt",testcase);
 
-        printf("Current Timestep: %d \n",current_timestamp);
-        pthread_mutex_lock(&shared_mem_mutex);
-        for(int i=0; i < num_requests; i++){
-            ShipRequest* request = &shared_memory->newShipRequests[i];
-           // printf("Direction %d, emergency %d\n",request->direction,request->emergency);
-            if(request->direction == 1 && request->emergency == 1){
-                enqueue(&Emergency_queue,*request);
-            }
-            else if(request->direction == -1){
-                enqueue(&OutGoing_queue,*request);
-            }
-            else{
-                enQueueRegularShips(&Regular_Queue,*request);
-            }
+
+    int main_msg_queue;
+    int shm_id;
+    core_init(&core,&sched,budget_policies[BUDGET_NORMAL]);
+    MainSharedMemory *shared_memory;
+
+    if(resume){
+        if(!checkpoint_open(checkpointName,1)){
+            exit(EXIT_FAILURE);
         }
+        resumeSlot = checkpoint_restore(&sched);
+    }
+    else{
+        read_input(fileName,&sched);
+        if(checkpoint_open(checkpointName,0)){
+            checkpoint_save(&sched,-1,NULL);
+        }
+        else{
+            fprintf(stderr,"Continuing without checkpoints\n");
+        }
+    }
 
-        // sort_queue_by_numCargo(&Emergency_queue);
-        // sort_queue_by_numCargo(&Regular_Queue);
-        // sort_queue_by_numCargo(&OutGoing_queue);
 
+    setup_ipc(&sched, &main_msg_queue, &shm_id, &shared_memory, !resume);
+    for(int i=0; i < sched.num_docks; i++){
+        pthread_mutex_init(&dock_mutex[i],NULL);
+    }
+    pthread_mutex_init(&shared_mem_mutex,NULL);
+    //InitShipRequestQueue(&queue);
 
-        int size_em = getQueueSize(&Emergency_queue);
-        int size_out = getQueueSize(&OutGoing_queue);
-        int size_reg = getQueueSize(&Regular_Queue);
+    // a timestep received but not yet snapshotted has sent nothing, so it is run again from its ship requests still in shared memory.
+    // otherwise the snapshotted timestep is finished from its cursor, without repeating what was already sent
+    if(resume){
+        if(checkpoint->inFlightValid && checkpoint->inFlight.timestep > resumeSlot->timestep){
+            MessageStruct pending = checkpoint->inFlight;
+            process_timestep(&sched,main_msg_queue,shared_memory,&pending);
+        }
+        else if(!resumeSlot->advanceSent){
+            static DecisionList pendingDecisions;
+            pendingDecisions = resumeSlot->decisions;
+            finish_timestep(&sched,main_msg_queue,shared_memory,&pendingDecisions,resumeSlot->sent);
+        }
+    }
+   
+    poll_requests(&sched,main_msg_queue,shared_memory);
+
+
+    for(int i = 0; i < sched.num_docks; i++) {
+        pthread_mutex_destroy(&dock_mutex[i]);
+    }
+    pthread_mutex_destroy(&shared_mem_mutex);
+    checkpoint_close(1);
+    run_stats.wallNs = now_ns() - budget.startNs;
 
 
-        for(int i=0; i < size_em; i++){
-            ShipRequest ship = dequeue(&Emergency_queue);
-            //printf("Ship->direction %d\n",ship.direction);
-            int docked = Docking(main_msg_queue,config,shared_memory,&ship,current_timestamp,1);
-            if(!docked){
-                enqueue(&Emergency_queue,ship);
+    return 0;
+}
+
+
+int ipc_key_in_use(int key){
+    return msgget(key, 0) != -1 || shmget(key, 0, 0) != -1;
+}
+
+
+// every scenario gets its own block of 16 keys, shifted by pid so concurrent batches do not collide either
+int remap_keys(SchedulerConfig* config,int index){
+    for(int attempt = 0; attempt < 256; attempt++){
+        int base = BATCH_KEY_BASE + (((getpid() + attempt) & 0xFFF) << 12) + index * 16;
+        int inUse = 0;
+        for(int k = 0; k < 2 + config->num_solvers; k++){
+            if(ipc_key_in_use(base + k)){
+                inUse = 1;
+                break;
             }
         }
+        if(inUse) continue;
 
-        for(int i=0; i < size_reg; i++){
-            ShipRequest ship = dequeue(&Regular_Queue);
-            int docked = Docking(main_msg_queue,config,shared_memory,&ship,current_timestamp,0);
-            if(docked == 2) continue;
-            else if(docked == 0){
-                enQueueRegularShips(&Regular_Queue,ship);
-            }
+        config->shared_mem_key = base;
+        config->main_msg_queue_key = base + 1;
+        for(int i = 0; i < config->num_solvers; i++){
+            config->solver_msg_queues[i] = base + 2 + i;
         }
+        return 1;
+    }
+    return 0;
+}
 
-        for(int i=0; i < size_out; i++){
-            ShipRequest ship = dequeue(&OutGoing_queue);
-            //printf("Ship->direction %d\n",ship.direction);
-            int docked = Docking(main_msg_queue,config,shared_memory,&ship,current_timestamp,1);
-            if(!docked){
-                enqueue(&OutGoing_queue,ship);
-            }
+
+void write_input(const char* fileName,SchedulerConfig* config){
+    FILE* file = fopen(fileName, "w");
+    if(!file){
+        perror("Error writing scenario input");
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "%d\n%d\n%d\n", config->shared_mem_key, config->main_msg_queue_key, config->num_solvers);
+    for(int i = 0; i < config->num_solvers; i++){
+        fprintf(file, "%d\n", config->solver_msg_queues[i]);
+    }
+    fprintf(file, "%d\n", config->num_docks);
+    for(int i = 0; i < config->num_docks; i++){
+        fprintf(file, "%d", config->docks[i].category);
+        for(int j = 0; j < config->docks[i].crane_count; j++){
+            fprintf(file, " %d", config->docks[i].cranes[j].capacity);
         }
-        pthread_mutex_unlock(&shared_mem_mutex);
-  
-        loadUnload(main_msg_queue,config,shared_memory,current_timestamp,num_requests);
+        fprintf(file, "\n");
+    }
+    fclose(file);
+}
+
+
+void prepare_scenario(Scenario* sc,const char* testcase,int index,const char* batchDir){
+    char path[PATH_MAX];
+    char target[PATH_MAX];
+    const char* shipFiles[] = {"normal_ships.txt", "emergency_ships.txt", "outgoing_ships.txt"};
+
+    snprintf(sc->testcase, sizeof(sc->testcase), "%s", testcase);
+    snprintf(path, sizeof(path), "testcase%s/input.txt", testcase);
+    read_input(path, &sc->config);
+    if(!remap_keys(&sc->config, index)){
+        fprintf(stderr, "No free IPC keys for scenario %d\n", index);
+        exit(EXIT_FAILURE);
+    }
+
+    snprintf(sc->dir, sizeof(sc->dir), "%s/s%d", batchDir, index);
+    snprintf(path, sizeof(path), "%s/testcase%s", sc->dir, testcase);
+    if(mkdir(sc->dir, 0755) == -1 || mkdir(path, 0755) == -1){
+        perror("Error creating scenario directory");
+        exit(EXIT_FAILURE);
+    }
+
+    snprintf(path, sizeof(path), "%s/testcase%s/input.txt", sc->dir, testcase);
+    write_input(path, &sc->config);
 
+    for(int i = 0; i < 3; i++){
+        snprintf(path, sizeof(path), "testcase%s/%s", testcase, shipFiles[i]);
+        if(realpath(path, target) == NULL){
+            perror(path);
+            exit(EXIT_FAILURE);
+        }
+        snprintf(path, sizeof(path), "%s/testcase%s/%s", sc->dir, testcase, shipFiles[i]);
+        if(symlink(target, path) == -1){
+            perror("Error linking ship file");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+
+void redirect_output(const char* dir,const char* name){
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1){
+        perror("Error opening log");
+        _exit(EXIT_FAILURE);
+    }
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+}
 
-        for(int i=0; i < config->num_docks; i++){
-            Dock* dock= &config->docks[i];
-            pthread_mutex_lock(&dock_mutex[i]);
-           // printf("%d dock occupied, dock last CargoTimestemp: %d, and dock ready to undock = %d\n",dock->occupied,dock->lastCargoTimestep,dock->readyToUndock);
-            if(dock->occupied && dock->lastCargoTimestep != -1 && dock->lastCargoTimestep < current_timestamp && dock->readyToUndock == 1){
-                unDocking(main_msg_queue,config->solver_msg_queues,dock,shared_memory,config);
+
+// returns 0 if a fork failed, whatever was started is left in the pids for abort_scenarios()
+int start_scenario(Scenario* sc,const char* validator,RunStats* stats){
+    fflush(stdout);
+    sc->validatorPid = fork();
+    if(sc->validatorPid == -1){
+        return 0;
+    }
+    if(sc->validatorPid == 0){
+        // own process group, so killing the validator also takes down the solver processes it spawns
+        setpgid(0, 0);
+        redirect_output(sc->dir, "validator.log");
+        if(chdir(sc->dir) == -1) _exit(EXIT_FAILURE);
+        execl(validator, "validation.out", sc->testcase, (char*)NULL);
+        _exit(127);
+    }
+    // set it from this side as well so a kill(-pid) right after fork already reaches the group.
+    // EACCES just means the child got to exec first, it has already done this itself
+    setpgid(sc->validatorPid, sc->validatorPid);
+
+    // same order as the two-terminal setup, validator first
+    usleep(100000);
+
+    sc->schedulerPid = fork();
+    if(sc->schedulerPid == 0){
+        redirect_output(sc->dir, "scheduler.log");
+        if(chdir(sc->dir) == -1) _exit(EXIT_FAILURE);
+        budget.timestepCap = sc->timestepCap;
+        budget.wallBudgetNs = sc->wallBudgetNs;
+        budget_policies[BUDGET_NORMAL] = sc->policy;
+        int status = run_scheduler(sc->testcase, 0);
+        fflush(stdout);
+        *stats = run_stats;
+        _exit(status);
+    }
+    return sc->schedulerPid != -1;
+}
+
+
+void cleanup_scenario_ipc(SchedulerConfig* config){
+    int qid = msgget(config->main_msg_queue_key, 0);
+    if(qid != -1) msgctl(qid, IPC_RMID, NULL);
+    for(int i = 0; i < config->num_solvers; i++){
+        qid = msgget(config->solver_msg_queues[i], 0);
+        if(qid != -1) msgctl(qid, IPC_RMID, NULL);
+    }
+    int shmId = shmget(config->shared_mem_key, 0, 0);
+    if(shmId != -1) shmctl(shmId, IPC_RMID, NULL);
+}
+
+
+void abort_scenarios(Scenario* scenarios,int count){
+    for(int i = 0; i < count; i++){
+        if(scenarios[i].validatorPid > 0){
+            kill(-scenarios[i].validatorPid, SIGKILL);
+            waitpid(scenarios[i].validatorPid, NULL, 0);
+        }
+        if(scenarios[i].schedulerPid > 0){
+            kill(scenarios[i].schedulerPid, SIGKILL);
+            waitpid(scenarios[i].schedulerPid, NULL, 0);
+        }
+        cleanup_scenario_ipc(&scenarios[i].config);
+    }
+}
+
+
+// when one side of a scenario exits, the other gets a grace period before it is killed so a failed run cannot hang the batch
+void wait_scenarios(Scenario* scenarios,int count){
+    long long exitedAt[MAX_SCENARIOS] = {0};
+    int running = count * 2;
+
+    while(running > 0){
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if(pid > 0){
+            for(int i = 0; i < count; i++){
+                if(pid == scenarios[i].validatorPid){
+                    scenarios[i].validatorStatus = status;
+                    scenarios[i].validatorPid = 0;
+                }
+                else if(pid == scenarios[i].schedulerPid){
+                    scenarios[i].schedulerStatus = status;
+                    scenarios[i].schedulerPid = 0;
+                }
+                else continue;
+                exitedAt[i] = now_ns();
+                running--;
             }
-            pthread_mutex_unlock(&dock_mutex[i]);
+            continue;
+        }
+        if(pid == -1 && errno == ECHILD){
+            break;
         }
 
+        for(int i = 0; i < count; i++){
+            if(exitedAt[i] == 0 || now_ns() - exitedAt[i] < 2000000000LL) continue;
+            if(scenarios[i].validatorPid > 0) kill(-scenarios[i].validatorPid, SIGKILL);
+            if(scenarios[i].schedulerPid > 0) kill(scenarios[i].schedulerPid, SIGKILL);
+        }
+        usleep(10000);
+    }
+}
 
 
-        MessageStruct msge;
-        msge.mtype = 5;
+int exit_code(int status){
+    if(WIFEXITED(status)) return WEXITSTATUS(status);
+    return 128 + WTERMSIG(status);
+}
 
 
-        if(msgsnd(main_msg_queue,&msge,sizeof(msge)-sizeof(long),0) == -1){
-            perror("Error Updating timestamp\n");
+void print_batch_table(Scenario* scenarios,RunStats* stats,int count,long long batchNs){
+    int totalUndocked = 0;
+    printf("\n%-8s %-8s %-14s %-10s %9s %7s %8s %8s %8s %12s %12s\n",
+        "Scenario", "Testcase", "Policy", "Result", "Timesteps", "Docked", "Undocked", "Wall(s)", "Ships/s", "AvgCrack(ms)", "MaxCrack(ms)");
+    for(int i = 0; i < count; i++){
+        RunStats* st = &stats[i];
+        int v = exit_code(scenarios[i].validatorStatus);
+        int sc = exit_code(scenarios[i].schedulerStatus);
+        char result[32];
+        if(v == 0 && sc == 0) snprintf(result, sizeof(result), "ok");
+        else snprintf(result, sizeof(result), "v=%d,s=%d", v, sc);
+
+        double wall = st->wallNs / 1e9;
+        printf("%-8d %-8s %-14s %-10s %9d %7d %8d %8.2f %8.1f %12.2f %12.2f\n",
+            i, scenarios[i].testcase, scenarios[i].policy->name, result, st->timesteps, st->shipsDocked, st->shipsUndocked, wall,
+            wall > 0 ? st->shipsUndocked / wall : 0.0,
+            st->shipsUndocked > 0 ? st->crackNsTotal / 1e6 / st->shipsUndocked : 0.0,
+            st->crackNsMax / 1e6);
+        totalUndocked += st->shipsUndocked;
+    }
+    printf("Batch: %d scenarios, %d ships undocked in %.2fs (%.1f ships/s)\n",
+        count, totalUndocked, batchNs / 1e9, batchNs > 0 ? totalUndocked / (batchNs / 1e9) : 0.0);
+}
+
+
+long long parse_positive(const char* option,const char* value,long long max){
+    char* end;
+    errno = 0;
+    long long n = strtoll(value, &end, 10);
+    if(errno != 0 || end == value || *end != '\0' || n <= 0 || n > max){
+        fprintf(stderr, "error: %s needs a positive whole number, got '%s'\n", option, value);
+        exit(EXIT_FAILURE);
+    }
+    return n;
+}
+
+
+// handles the scheduler option at argv[i], returns how many arguments it took, 0 if argv[i] is not one
+int parse_scheduler_option(int argc,char* argv[],int i){
+    if(i + 1 >= argc){
+        return 0;
+    }
+    if(strcmp(argv[i],"--timestep-cap") == 0){
+        budget.timestepCap = (int)parse_positive(argv[i], argv[i + 1], INT_MAX);
+        return 2;
+    }
+    if(strcmp(argv[i],"--wall-budget") == 0){
+        budget.wallBudgetNs = parse_positive(argv[i], argv[i + 1], LLONG_MAX / 1000000000LL) * 1000000000LL;
+        return 2;
+    }
+    if(strcmp(argv[i],"--policy") == 0){
+        const SchedulingPolicy* policy = core_find_policy(argv[i + 1]);
+        if(policy == NULL){
+            fprintf(stderr, "error: unknown policy '%s'\n", argv[i + 1]);
             exit(EXIT_FAILURE);
         }
-        printf("TimeStamp update request sent\n");
-        usleep(1);
+        budget_policies[BUDGET_NORMAL] = policy;
+        return 2;
     }
+    return 0;
 }
 
-int main(int argc,char* argv[]){    
-    if(argc != 2){
-        perror("Error in command Line args\n");
-        exit(0);
+
+int run_batch(int argc,char* argv[]){
+    Scenario scenarios[MAX_SCENARIOS];
+    memset(scenarios, 0, sizeof(scenarios));
+    char* testcases[MAX_SCENARIOS];
+    int count = 0;
+
+    // options apply to every testcase after them, so scenarios can differ in one batch
+    for(int i = 0; i < argc; i++){
+        int used = parse_scheduler_option(argc, argv, i);
+        if(used > 0){
+            i += used - 1;
+            continue;
+        }
+        if(argv[i][0] == '-'){
+            fprintf(stderr, "error: unknown batch option '%s'\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        if(count == MAX_SCENARIOS){
+            fprintf(stderr, "error: between 1 and %d scenarios per batch\n", MAX_SCENARIOS);
+            return EXIT_FAILURE;
+        }
+        scenarios[count].timestepCap = budget.timestepCap;
+        scenarios[count].wallBudgetNs = budget.wallBudgetNs;
+        scenarios[count].policy = budget_policies[BUDGET_NORMAL];
+        testcases[count++] = argv[i];
+    }
+    if(count < 1){
+        fprintf(stderr, "error: between 1 and %d scenarios per batch\n", MAX_SCENARIOS);
+        return EXIT_FAILURE;
     }
-    SchedulerConfig sched;
-    char fileName[256];
-    snprintf(fileName,sizeof(fileName),"testcase%s/input.txt",argv[1]);
-   
-    read_input(fileName,&sched);
 
+    char validator[PATH_MAX];
+    if(realpath("validation.out", validator) == NULL){
+        perror("validation.out");
+        return EXIT_FAILURE;
+    }
 
-    int main_msg_queue;
-    int shm_id;
-    InitQueue(&Emergency_queue);
-    InitQueue(&Regular_Queue);
-    InitQueue(&OutGoing_queue);
-    MainSharedMemory *shared_memory;
+    char batchDir[256];
+    snprintf(batchDir, sizeof(batchDir), "batch_%d", getpid());
+    if(mkdir(batchDir, 0755) == -1){
+        perror("Error creating batch directory");
+        return EXIT_FAILURE;
+    }
 
+    RunStats* stats = mmap(NULL, sizeof(RunStats) * count, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(stats == MAP_FAILED){
+        perror("Error mapping batch stats");
+        return EXIT_FAILURE;
+    }
+    memset(stats, 0, sizeof(RunStats) * count);
 
-    setup_ipc(&sched, &main_msg_queue, &shm_id, &shared_memory);
-    for(int i=0; i < sched.num_docks; i++){
-        pthread_mutex_init(&dock_mutex[i],NULL);
+    for(int i = 0; i < count; i++){
+        prepare_scenario(&scenarios[i], testcases[i], i, batchDir);
     }
-    pthread_mutex_init(&shared_mem_mutex,NULL);
-    //InitShipRequestQueue(&queue);
-   
-    poll_requests(&sched,main_msg_queue,shared_memory);
 
+    long long batchStart = now_ns();
+    for(int i = 0; i < count; i++){
+        if(!start_scenario(&scenarios[i], validator, &stats[i])){
+            perror("Error starting scenario");
+            abort_scenarios(scenarios, i + 1);
+            munmap(stats, sizeof(RunStats) * count);
+            return EXIT_FAILURE;
+        }
+    }
+    wait_scenarios(scenarios, count);
+    long long batchNs = now_ns() - batchStart;
 
-    for(int i = 0; i < sched.num_docks; i++) {
-        pthread_mutex_destroy(&dock_mutex[i]);
+    for(int i = 0; i < count; i++){
+        cleanup_scenario_ipc(&scenarios[i].config);
     }
-    pthread_mutex_destroy(&shared_mem_mutex);
 
+    print_batch_table(scenarios, stats, count, batchNs);
+    printf("Logs in %s/\n", batchDir);
+    munmap(stats, sizeof(RunStats) * count);
+    return EXIT_SUCCESS;
+}
 
-    return 0;
+
+int main(int argc,char* argv[]){    
+    if(argc >= 2 && strcmp(argv[1],"--batch") == 0){
+        return run_batch(argc - 2, argv + 2);
+    }
+    if(argc < 2){
+        perror("Error in command Line args\n");
+        exit(0);
+    }
+
+    int resume = 0;
+    for(int i = 2; i < argc; i++){
+        int used = parse_scheduler_option(argc, argv, i);
+        if(used > 0){
+            i += used - 1;
+        }
+        else if(strcmp(argv[i],"--resume") == 0){
+            resume = 1;
+        }
+        else{
+            perror("Error in command Line args\n");
+            exit(0);
+        }
+    }
+    return run_scheduler(argv[1], resume);
 }
\ No newline at end of file